@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <list>
 #include <vector>
+#include <mutex>
+#include <pthread.h>
 
 using namespace std;
 
@@ -22,6 +24,11 @@ class InvertedIndex
         unordered_map<string, float> IDF; // the idf value for each word in our dictionary
         vector<int> docsMaxFreq; //max term frequency of every document
         vector<float> docsMagnitudes; //|doc| the magnitude (metro dianismatos) of the doc
+        vector<bool> deletedDocs; //bitmap of the deleted documents, checked by the queries
+        int deletedCount; //how many documents are deleted
+        int purgedCount; //how many of the deleted documents have been removed from the lists
+        pthread_rwlock_t indexLock; //queries read the index while deletions, updates and compaction change it
+        mutex compactionMutex; //only one compaction or update at a time
 
     public:
         InvertedIndex(int totalDocs);
@@ -32,7 +39,12 @@ class InvertedIndex
         void calculateTF();                                 // calculate term frequency
         void calculateIDFandBuildDocMagnitudes();           // calculate IDF values and doc magnitudes sums
         void joinIndex(InvertedIndex *otherIndex);          // connect all created indexes in one
-        void executeQuery(string queryLine);                // answer the queries with consine similarity(documents-query)
+        void executeQuery(string queryLine);                // answer the queries with consine similarity(documents-query) and print them
+        string answerQuery(string queryLine);               // answer a query and return the printable results
+        bool deleteDocument(int docID);                     // mark a document as deleted
+        int updateDocument(int docID, string documentLine); // replace a document, returns its new docID
+        float deletedRatio();                               // part of the docs deleted but not compacted yet
+        long compact();                                     // remove deleted docs from the lists and recalculate IDF
         static mutex printMutex;                            // necessary variable to print the results seperately for each query
         void printIndex();                                  // prints all elements of index - used for debugging
         string convertToLowerCase(string documentLine);     // convert document words into lower case
@@ -0,0 +1,32 @@
+#ifndef LOADCLIENT_H
+#define LOADCLIENT_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+class LoadClient
+{
+    private:
+        string socketPath;              // the socket the query server listens on
+        vector<string> queries;         // the queries we send, in a circle
+        int noConnections;              // how many clients run concurrently
+        int totalRequests;              // how many queries are sent in total
+        atomic<int> nextRequest;        // the next query to be sent by any connection
+
+        mutex resultsMutex;
+        vector<double> latencies;       // in microseconds, of every answered query
+        long answered, expired, busy, malformed, failed;
+
+        void connectionLoop();          // send queries one by one and wait for each answer
+
+    public:
+        LoadClient(string socketPath, int noConnections, int totalRequests);
+        bool loadQueries(string queriesPath);  // read the queries, the same format as for the one-shot mode
+        void run();                            // generate the load and print QPS and latency percentiles
+};
+
+#endif // LOADCLIENT_H
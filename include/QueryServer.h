@@ -0,0 +1,97 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "InvertedIndex.h"
+
+using namespace std;
+
+typedef struct QueryRequest{
+    long connectionID;   // the connection that sent the query
+    string queryLine;    // the query as it was received, "<queryID> <top-k> <words>" or a command
+    chrono::steady_clock::time_point deadline; // if a worker has not started the query until then, it is answered with "Expired:"
+} QueryRequest;
+
+typedef struct QueryResponse{
+    long connectionID;   // the connection that waits for the answer
+    string text;         // the answer, always ending with an empty line
+} QueryResponse;
+
+typedef struct Connection{
+    int inFd;            // where the queries are read from
+    int outFd;           // where the answers are written to (same as inFd for sockets)
+    string inBuffer;     // received bytes, full lines are kept here while too many answers wait
+    string outBuffer;    // answers that are not written yet
+    int pending;         // queries of this connection that are still at the workers
+    bool commandPending; // a command is executing, the next lines wait for it
+    bool closing;        // the peer has nothing more to send, close when all answers are written
+    unsigned int events; // the epoll events we currently wait for
+    unsigned int outEvents; // the epoll events of outFd, when it is not inFd
+} Connection;
+
+class QueryServer
+{
+    private:
+        InvertedIndex *index;           // the index that answers all the queries, built only once
+        string socketPath;              // path of the unix domain socket we listen on
+        int noWorkers;                  // number of threads that execute queries
+        unsigned int maxQueued;         // admission control: queries waiting above this are rejected
+        int deadlineMillis;             // how long a query may wait in the queue
+
+        int epollFd, listenFd, wakeFd, signalFd;
+        long nextConnectionID;
+        long stdoutConnectionID;        // the connection of the standard input, -1 if it is not served
+        int stdoutFlags;                // the flags of the standard output before we made it non-blocking
+        unordered_map<long, Connection> connections;
+
+        deque<QueryRequest> requests;   // queries waiting for a worker
+        mutex requestsMutex;
+        condition_variable requestsCondition;
+        bool stopping;
+
+        deque<QueryResponse> responses; // answers waiting to be sent by the event loop
+        mutex responsesMutex;
+
+        vector<thread> workers;
+        long acceptedQueries, rejectedQueries, malformedQueries;
+        atomic<long> answeredQueries, expiredQueries, commandsExecuted;
+
+        thread maintainer;                              // updates and compacts the index in the background
+        deque<QueryRequest> maintenanceRequests;        // updates and compact commands waiting for the maintainer
+        condition_variable maintenanceCondition;        // uses requestsMutex, like the workers
+        bool compactionRequested;
+        atomic<long> compactions;
+
+        void workerLoop();                              // take queries from the queue and answer them
+        void pushResponse(long connectionID, const string &text); // give an answer to the event loop
+        string executeCommand(const string &commandLine); // delete, update or compact the index
+        void requestCompaction();                       // wake up the maintainer to compact
+        void maintenanceLoop();                         // execute updates and compactions, one at a time
+        void acceptConnections();                       // accept every waiting client of the socket
+        void addConnection(int inFd, int outFd);        // start serving a new client
+        void readConnection(long connectionID);         // read whatever the client sent us
+        bool handleBufferedLines(long connectionID);    // handle the received lines while there is room for their answers
+        bool handleLine(long connectionID, const string &line); // admit or reject a single query
+        void deliverResponses();                        // move finished answers to their connections
+        void flushConnection(long connectionID);        // write as much as possible of the pending answers
+        void updateEvents(long connectionID);           // wait for input and/or output according to the state
+        void closeConnection(long connectionID);        // stop serving a client and free its descriptors
+
+    public:
+        QueryServer(InvertedIndex *index, string socketPath, int noWorkers, unsigned int maxQueued, int deadlineMillis);
+        virtual ~QueryServer();
+        bool start();                                   // create the socket and the workers
+        void run();                                     // serve until SIGINT or SIGTERM arrives
+        static bool isValidQuery(const string &queryLine); // check that the line is "<queryID> <top-k> ..."
+        static bool isValidCommand(const string &commandLine); // check that the line is "delete <docID>", "update <docID> <text>" or "compact"
+};
+
+#endif // QUERYSERVER_H
@@ -2,8 +2,14 @@
 #include <fstream>
 #include <mutex>
 #include <thread>
+#include <stdlib.h> //atoi
+#include <string.h> //strcmp
+#include <random>
+#include <algorithm>
 #include <sys/time.h>
 #include "InvertedIndex.h"
+#include "QueryServer.h"
+#include "LoadClient.h"
 
 using namespace std;
 
@@ -86,7 +92,11 @@ void executeQueries(InvertedIndex *index)
 }
 
 
-int main()
+/**
+* Builds the inverted index of the documents file with all the available
+* threads and returns it, ready to answer queries.
+*/
+InvertedIndex *createIndex(int noConcurrentThreads)
 {
     //used to acquire documents, line by line
     std::string line;
@@ -97,13 +107,9 @@ int main()
     totalDocs = atoi(line.c_str());
     cout << "Total Documents: " << totalDocs << endl;
 
-    //used to identify number of threads available
-    int noConcurrentThreads = thread::hardware_concurrency();
-    cout << "We will work on " << noConcurrentThreads << " concurrent threads" << endl;
-
     documentsCounter = -1; //set to start docIDs from zero (0).
 
-    struct timeval startTime,endTime,midTime;
+    struct timeval startTime,endTime;
     gettimeofday(&startTime,NULL);
 
     vector<InvertedIndex*> indexes(noConcurrentThreads);
@@ -131,20 +137,32 @@ int main()
     for(unsigned int i=1; i<indexes.size(); i++)
     {
         indexes[0]->joinIndex(indexes[i]);
+        delete indexes[i];
     }
     indexes[0]->calculateIDFandBuildDocMagnitudes();
 
-    gettimeofday(&midTime,NULL);
+    gettimeofday(&endTime,NULL);
 
     long startTotalMicro = startTime.tv_sec * 1000000 + startTime.tv_usec;
-    long endTotalMicro = midTime.tv_sec * 1000000 + midTime.tv_usec;
+    long endTotalMicro = endTime.tv_sec * 1000000 + endTime.tv_usec;
     long microseconds = endTotalMicro - startTotalMicro ;
     double seconds = microseconds / 1000000.0;
 
     cout<<endl<<"Index created in: "<< seconds <<"  seconds."<<endl<<endl<<endl;
 
-    threads.clear();
-    threads.resize(noConcurrentThreads);
+    return indexes[0];
+}
+
+/**
+* Answers all the queries of the queries file with all the available threads.
+*/
+void answerQueriesFile(InvertedIndex *index, int noConcurrentThreads)
+{
+    std::string line;
+    struct timeval startTime,endTime;
+    gettimeofday(&startTime,NULL);
+
+    vector<thread> threads(noConcurrentThreads);
 
     input.open("queries/queries2.txt");
     queriesCounter = -1;
@@ -155,7 +173,7 @@ int main()
 
     for(unsigned int i=0; i<threads.size(); ++i)
     {
-        threads[i] = thread(executeQueries, indexes[0]);
+        threads[i] = thread(executeQueries, index);
     }
 
     for(unsigned int i=0; i<threads.size(); ++i)
@@ -166,16 +184,154 @@ int main()
     input.close();
 
     gettimeofday(&endTime,NULL);
-    startTotalMicro = midTime.tv_sec * 1000000 + midTime.tv_usec;
-    endTotalMicro = endTime.tv_sec * 1000000 + endTime.tv_usec;
-    microseconds = endTotalMicro - startTotalMicro ;
-    seconds = microseconds / 1000000.0;
+    long startTotalMicro = startTime.tv_sec * 1000000 + startTime.tv_usec;
+    long endTotalMicro = endTime.tv_sec * 1000000 + endTime.tv_usec;
+    long microseconds = endTotalMicro - startTotalMicro ;
+    double seconds = microseconds / 1000000.0;
 
     cout<<endl<<"All queries where answered in: "<< seconds <<"  seconds."<<endl<<endl<<endl;
+}
 
-    for(unsigned int i = 0; i < indexes.size(); i++){
-        delete indexes[i];
+/**
+* Returns the microseconds passed since startTime.
+*/
+long elapsedMicroseconds(struct timeval startTime)
+{
+    struct timeval endTime;
+    gettimeofday(&endTime,NULL);
+    return (endTime.tv_sec * 1000000 + endTime.tv_usec) - (startTime.tv_sec * 1000000 + startTime.tv_usec);
+}
+
+/**
+* Answers all the queries of the queries file `rounds` times in one thread
+* and returns the average microseconds of a query.
+*/
+double timeQueries(InvertedIndex *index, vector<string> &queries, int rounds)
+{
+    struct timeval startTime;
+    gettimeofday(&startTime,NULL);
+
+    for(int r = 0; r < rounds; r++)
+    {
+        for(unsigned int i = 0; i < queries.size(); i++)
+        {
+            index->answerQuery(queries[i]);
+        }
     }
 
+    return 1.0 * elapsedMicroseconds(startTime) / (rounds * queries.size());
+}
+
+/**
+* Measures how much the deleted documents cost the queries before they are compacted,
+* and how fast the compaction purges them. Documents are deleted in random order
+* (always the same) until each ratio is reached.
+*/
+void benchmarkDeletes(InvertedIndex *index, int rounds)
+{
+    vector<string> queries;
+    std::string line;
+
+    input.open("queries/queries2.txt");
+    std::getline(input,line);
+    totalQueries = atoi(line.c_str());
+    for(int i = 0; i < totalQueries && std::getline(input,line); i++)
+    {
+        queries.push_back(line);
+    }
+    input.close();
+
+    if(queries.empty() || totalDocs == 0)
+    {
+        cout << "Nothing to benchmark" << endl;
+        return;
+    }
+
+    vector<int> deleteOrder(totalDocs);
+    for(int i = 0; i < totalDocs; i++)
+    {
+        deleteOrder[i] = i;
+    }
+    std::mt19937 generator(42);
+    std::shuffle(deleteOrder.begin(), deleteOrder.end(), generator);
+
+    double ratios[] = {0, 0.01, 0.1, 0.25, 0.5};
+    int deleted = 0;
+
+    //one untimed pass, so the first ratio does not pay for the cold caches
+    timeQueries(index, queries, 1);
+
+    cout << "Queries answered " << rounds << " times before compaction:" << endl;
+    for(unsigned int r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++)
+    {
+        while(deleted < ratios[r] * totalDocs)
+        {
+            index->deleteDocument(deleteOrder[deleted]);
+            deleted++;
+        }
+        cout << "  deleted " << ratios[r] * 100 << "%: " << timeQueries(index, queries, rounds) << " microseconds per query" << endl;
+    }
+
+    struct timeval startTime;
+    gettimeofday(&startTime,NULL);
+    long postings = index->compact();
+    double seconds = elapsedMicroseconds(startTime) / 1000000.0;
+
+    cout << "Compaction of " << postings << " postings in " << seconds << " seconds ("
+         << (seconds > 0 ? postings / seconds : 0) << " postings per second)" << endl;
+    cout << "  after compaction: " << timeQueries(index, queries, rounds) << " microseconds per query" << endl;
+}
+
+/**
+* Usage:
+*   InfoRetr                                                  builds the index and answers queries/queries2.txt
+*   InfoRetr --serve <socket> [workers] [queue] [deadlineMs]  builds the index once and serves queries on a unix socket and stdin
+*   InfoRetr --client <socket> <queriesFile> [connections] [requests]  load generator for a running server
+*   InfoRetr --bench-deletes [rounds]                         query cost at several delete ratios and compaction speed
+*/
+int main(int argc, char *argv[])
+{
+    if(argc >= 4 && strcmp(argv[1], "--client") == 0)
+    {
+        LoadClient client(argv[2], argc > 4 ? atoi(argv[4]) : 4, argc > 5 ? atoi(argv[5]) : 10000);
+        if(!client.loadQueries(argv[3]))
+        {
+            cerr << "Could not read queries from " << argv[3] << endl;
+            return 1;
+        }
+        client.run();
+        return 0;
+    }
+
+    //used to identify number of threads available
+    int noConcurrentThreads = thread::hardware_concurrency();
+    cout << "We will work on " << noConcurrentThreads << " concurrent threads" << endl;
+
+    InvertedIndex *index = createIndex(noConcurrentThreads);
+
+    if(argc >= 3 && strcmp(argv[1], "--serve") == 0)
+    {
+        QueryServer server(index, argv[2],
+                           argc > 3 ? atoi(argv[3]) : noConcurrentThreads,
+                           argc > 4 ? atoi(argv[4]) : 1024,
+                           argc > 5 ? atoi(argv[5]) : 1000);
+        if(!server.start())
+        {
+            delete index;
+            return 1;
+        }
+        server.run();
+    }
+    else if(argc >= 2 && strcmp(argv[1], "--bench-deletes") == 0)
+    {
+        benchmarkDeletes(index, argc > 2 ? atoi(argv[2]) : 1000);
+    }
+    else
+    {
+        answerQueriesFile(index, noConcurrentThreads);
+    }
+
+    delete index;
+
     return 0;
 }
@@ -14,12 +14,23 @@ mutex InvertedIndex::printMutex;
 
 /**
 * Sets the max freq and magnitude vectors to the
-* number of docs that we have.
+* number of docs that we have. The lock prefers writers, otherwise
+* a steady load of queries keeps deletions and updates waiting.
 */
 InvertedIndex::InvertedIndex(int totalDocs)
 {
     docsMaxFreq.resize(totalDocs);
     docsMagnitudes.resize(totalDocs);
+    deletedDocs.resize(totalDocs);
+    deletedCount = 0;
+    purgedCount = 0;
+
+    //no thread takes the read lock twice, so writers may go first without deadlocks
+    pthread_rwlockattr_t lockAttributes;
+    pthread_rwlockattr_init(&lockAttributes);
+    pthread_rwlockattr_setkind_np(&lockAttributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&indexLock, &lockAttributes);
+    pthread_rwlockattr_destroy(&lockAttributes);
 }
 
 /**
@@ -33,6 +44,7 @@ InvertedIndex::~InvertedIndex()
         delete unordered_mapIt->second;
     }
     dictionary.clear();
+    pthread_rwlock_destroy(&indexLock);
 }
 
 
@@ -170,7 +182,7 @@ void InvertedIndex::calculateIDFandBuildDocMagnitudes()
     {
         //it->first: the string of the current word being processed.
         //it->second->size(): the number of documents that possess the current word.
-        IDF[it->first] = log2(1.0  + (1.0*docsMaxFreq.size()) / it->second->size()); //log2(1 + N/nt)
+        IDF[it->first] = log2(1.0  + (1.0*(docsMaxFreq.size() - deletedCount)) / it->second->size()); //log2(1 + N/nt), N counts only the live docs
         list<DocWordData> *documentEntries = it->second;
 
         //Increase the mangnitude of all the documents that contain the word, building the magnitude sum
@@ -227,6 +239,176 @@ void InvertedIndex::joinIndex(InvertedIndex *otherIndex)
 }
 
 
+/**
+* Deletes a document. Only its bit in the deleted-docs bitmap is set, so the queries
+* skip it; its postings are physically removed by the next compaction.
+* Returns false if the document does not exist or is already deleted.
+*/
+bool InvertedIndex::deleteDocument(int docID)
+{
+    bool deleted = false;
+
+    pthread_rwlock_wrlock(&indexLock);
+    if(docID >= 0 && docID < (int) deletedDocs.size() && !deletedDocs[docID])
+    {
+        deletedDocs[docID] = true;
+        deletedCount++;
+        deleted = true;
+    }
+    pthread_rwlock_unlock(&indexLock);
+
+    return deleted;
+}
+
+/**
+* Replaces a document with a new version. The old version is deleted and the new one
+* gets the next free docID, so no list has it yet and add() finds it at the back.
+* The new postings are weighted with the current IDF values, which are
+* recalculated for all the documents by the next compaction.
+* Returns the new docID, or -1 if the document does not exist or is deleted.
+*/
+int InvertedIndex::updateDocument(int docID, string documentLine)
+{
+    documentLine = convertToLowerCase(documentLine); //string to lower case
+
+    istringstream temp(documentLine); // Input stream class to operate on strings.
+
+    vector<string> tokens;
+    copy(istream_iterator<string>(temp),istream_iterator<string>(),back_inserter(tokens));
+
+    //the compaction reads the lists without locking, so it must not run while we add postings
+    compactionMutex.lock();
+    pthread_rwlock_wrlock(&indexLock);
+
+    if(docID < 0 || docID >= (int) deletedDocs.size() || deletedDocs[docID])
+    {
+        pthread_rwlock_unlock(&indexLock);
+        compactionMutex.unlock();
+        return -1;
+    }
+
+    deletedDocs[docID] = true;
+    deletedCount++;
+
+    int newDocID = docsMaxFreq.size();
+    docsMaxFreq.push_back(0);
+    docsMagnitudes.push_back(0);
+    deletedDocs.push_back(false);
+
+    for(unsigned int i = 0 ; i < tokens.size() ; i++)
+    {
+        this->add(tokens[i],newDocID,i);
+    }
+
+    //the new document is the last entry in the list of each of its words
+    for(unsigned int i = 0 ; i < tokens.size() ; i++)
+    {
+        if(docsMaxFreq[newDocID] < dictionary[tokens[i]]->back().freq)
+        {
+            docsMaxFreq[newDocID] = dictionary[tokens[i]]->back().freq;
+        }
+    }
+
+    float magnitude = 0;
+    for(unsigned int i = 0 ; i < tokens.size() ; i++)
+    {
+        list<DocWordData> *documentEntries = dictionary[tokens[i]];
+        DocWordData &entry = documentEntries->back();
+        if(entry.TF != 0) //word seen before in this document
+        {
+            continue;
+        }
+        entry.TF = 1.0 * entry.freq / docsMaxFreq[newDocID];
+
+        if(IDF.find(tokens[i]) == IDF.end()) //word that no other document has
+        {
+            IDF[tokens[i]] = log2(1.0  + (1.0*(docsMaxFreq.size() - deletedCount)) / documentEntries->size());
+        }
+
+        float tmp = entry.TF * IDF[tokens[i]];
+        magnitude += tmp * tmp;
+    }
+    docsMagnitudes[newDocID] = sqrt(magnitude);
+
+    pthread_rwlock_unlock(&indexLock);
+    compactionMutex.unlock();
+
+    return newDocID;
+}
+
+/**
+* Returns the part of the documents that are deleted but still have postings in the lists.
+*/
+float InvertedIndex::deletedRatio()
+{
+    pthread_rwlock_rdlock(&indexLock);
+    float ratio = deletedDocs.size() == 0 ? 0 : 1.0 * (deletedCount - purgedCount) / deletedDocs.size();
+    pthread_rwlock_unlock(&indexLock);
+
+    return ratio;
+}
+
+/**
+* Rewrites the lists without the postings of the deleted documents and recalculates
+* the IDF values and the doc magnitudes. The new lists are built in a separate index
+* while the queries keep reading the current one; the lock is held for writing only
+* to swap them in. Documents deleted meanwhile stay hidden by the bitmap.
+* Returns the number of postings that were examined.
+*/
+long InvertedIndex::compact()
+{
+    compactionMutex.lock();
+
+    pthread_rwlock_rdlock(&indexLock);
+    vector<bool> deleted = deletedDocs;
+    int deletedSnapshot = deletedCount;
+    pthread_rwlock_unlock(&indexLock);
+
+    InvertedIndex compacted(docsMaxFreq.size());
+    compacted.docsMaxFreq = docsMaxFreq;
+    compacted.deletedDocs = deleted;
+    compacted.deletedCount = deletedSnapshot;
+
+    long postings = 0;
+    for(unordered_map<string,list<DocWordData>*>::iterator it = dictionary.begin(); it != dictionary.end(); ++it)
+    {
+        list<DocWordData> *liveEntries = nullptr;
+
+        for(list<DocWordData>::iterator listIt = it->second->begin(); listIt != it->second->end(); ++listIt)
+        {
+            postings++;
+            if(deleted[listIt->docID])
+            {
+                continue;
+            }
+            if(liveEntries == nullptr)
+            {
+                liveEntries = new list<DocWordData>();
+            }
+            liveEntries->push_back(*listIt);
+        }
+
+        //words that only deleted documents had are dropped
+        if(liveEntries != nullptr)
+        {
+            compacted.dictionary[it->first] = liveEntries;
+        }
+    }
+    compacted.calculateIDFandBuildDocMagnitudes();
+
+    pthread_rwlock_wrlock(&indexLock);
+    dictionary.swap(compacted.dictionary);
+    IDF.swap(compacted.IDF);
+    docsMagnitudes.swap(compacted.docsMagnitudes);
+    purgedCount = deletedSnapshot;
+    pthread_rwlock_unlock(&indexLock);
+
+    compactionMutex.unlock();
+
+    return postings; //the old lists are freed with the compacted index
+}
+
+
 /**
 * Prints the current index. Used for debugging.
 */
@@ -279,13 +461,27 @@ bool myCompare (pair<float,int> i,pair<float,int> j)
     return (i.first>j.first);
 }
 
+/**
+* Answers a query and prints its results. The printing is protected
+* so the results of each query are not mixed with the others.
+*/
+ void InvertedIndex::executeQuery(string queryLine)
+ {
+    string answer = answerQuery(queryLine);
+
+    printMutex.lock();
+    cout << answer;
+    printMutex.unlock();
+ }
+
 /**
 * The main function for answering the queries.
 * We find the ID and the amount of results that we should return.
 * We calculate the TF*IDF for each word and the similarity of each document to the query.
-* Finally, we sort the results and print specific amount.
+* Finally, we sort the results and return the specific amount formatted as text,
+* ending with an empty line.
 */
- void InvertedIndex::executeQuery(string queryLine)
+ string InvertedIndex::answerQuery(string queryLine)
  {
     //find the document ID
     int c1=0,c2,queryID = 0,querySize = 0;
@@ -328,6 +524,9 @@ bool myCompare (pair<float,int> i,pair<float,int> j)
 
     unordered_map<string, float> queryVector;
 
+    //the index may be changed by deletions, updates and compaction while we read it
+    pthread_rwlock_rdlock(&indexLock);
+
     int max = 0;
     //find the word with the max frequency, so after to calculate TF of each word in query
     for(int i = 0; i < tokens.size() ; i++)
@@ -406,6 +605,12 @@ bool myCompare (pair<float,int> i,pair<float,int> j)
             {
                 int docID = listIt->docID;
 
+                //deleted documents stay in the lists until the next compaction
+                if(deletedDocs[docID])
+                {
+                    continue;
+                }
+
                 std::unordered_map<int,float>::const_iterator gotDoc = similarities.find (docID);
                 //If first time
                 if(gotDoc == similarities.end())
@@ -436,6 +641,8 @@ bool myCompare (pair<float,int> i,pair<float,int> j)
         i++;
     }
 
+    pthread_rwlock_unlock(&indexLock);
+
 
 
     //Print top-k results that the user wants if we find more
@@ -447,18 +654,17 @@ bool myCompare (pair<float,int> i,pair<float,int> j)
     std::sort(results.begin(),results.end(),myCompare); //sort results
 
 
-    printMutex.lock();
-    cout <<"Top-" <<querySize << " results of query "<<queryID<< ":\""<<queryLine<<"\""<<endl;
+    ostringstream answer;
+    answer <<"Top-" <<querySize << " results of query "<<queryID<< ":\""<<queryLine<<"\""<<endl;
     if(results.size() == 0){
-        cout<<"No results found!!!"<<endl;
+        answer<<"No results found!!!"<<endl;
     }
 
     for(int j=0; j < results.size(); j++)
     {
-        cout << j+1<<":  DocID:"<<results[j].second<<"    Score :"<<results[j].first<<endl;
+        answer << j+1<<":  DocID:"<<results[j].second<<"    Score :"<<results[j].first<<endl;
     }
-    cout<<endl;
-    printMutex.unlock();
-
+    answer<<endl;
 
+    return answer.str();
  }
@@ -0,0 +1,183 @@
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h> //atoi
+#include <string.h> //strerror
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "LoadClient.h"
+
+using namespace std;
+
+/**
+* Keeps the settings of the load generation.
+*/
+LoadClient::LoadClient(string socketPath, int noConnections, int totalRequests)
+{
+    this->socketPath = socketPath;
+    this->noConnections = noConnections > 0 ? noConnections : 1;
+    this->totalRequests = totalRequests > 0 ? totalRequests : 1;
+    nextRequest = 0;
+    answered = expired = busy = malformed = failed = 0;
+}
+
+/**
+* Reads the queries from a file. The first line is the number of
+* queries, exactly like the file that the one-shot mode answers.
+* Empty lines are skipped, since the server never answers them.
+*/
+bool LoadClient::loadQueries(string queriesPath)
+{
+    ifstream input(queriesPath.c_str());
+    string line;
+
+    if(!std::getline(input, line))
+    {
+        return false;
+    }
+    unsigned int totalQueries = atoi(line.c_str());
+
+    while(queries.size() < totalQueries && std::getline(input, line))
+    {
+        if(!line.empty() && line[line.length() - 1] == '\r')
+        {
+            line.erase(line.length() - 1);
+        }
+        if(line.empty())
+        {
+            continue;
+        }
+        queries.push_back(line);
+    }
+
+    return !queries.empty();
+}
+
+/**
+* Executed by every connection thread. Sends one query, waits for the whole
+* answer (it ends with an empty line) and measures the time in between.
+*/
+void LoadClient::connectionLoop()
+{
+    vector<double> myLatencies;
+    long myAnswered = 0, myExpired = 0, myBusy = 0, myMalformed = 0, myFailed = 0;
+
+    int socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    if(socketFd < 0 || connect(socketFd, (struct sockaddr*) &address, sizeof(address)) < 0)
+    {
+        resultsMutex.lock();
+        cerr << "Could not connect to " << socketPath << ": " << strerror(errno) << endl;
+        failed++;
+        resultsMutex.unlock();
+        if(socketFd >= 0) close(socketFd);
+        return;
+    }
+
+    string received;
+    char buffer[4096];
+    bool connected = true;
+
+    for(int request = nextRequest++; request < totalRequests && connected; request = nextRequest++)
+    {
+        string queryLine = queries[request % queries.size()] + "\n";
+        chrono::steady_clock::time_point sentTime = chrono::steady_clock::now();
+
+        if(send(socketFd, queryLine.data(), queryLine.length(), MSG_NOSIGNAL) != (ssize_t) queryLine.length())
+        {
+            myFailed++;
+            break;
+        }
+
+        size_t end;
+        while((end = received.find("\n\n")) == string::npos)
+        {
+            ssize_t n = recv(socketFd, buffer, sizeof(buffer), 0);
+            if(n <= 0)
+            {
+                connected = false;
+                break;
+            }
+            received.append(buffer, n);
+        }
+        if(!connected)
+        {
+            myFailed++;
+            break;
+        }
+
+        chrono::steady_clock::time_point answerTime = chrono::steady_clock::now();
+        string answer = received.substr(0, end);
+        received.erase(0, end + 2);
+
+        if(answer.compare(0, 4, "Top-") == 0)
+        {
+            myAnswered++;
+            myLatencies.push_back(chrono::duration<double, micro>(answerTime - sentTime).count());
+        }
+        else if(answer.compare(0, 8, "Expired:") == 0) myExpired++;
+        else if(answer.compare(0, 5, "Busy:") == 0) myBusy++;
+        else myMalformed++;
+    }
+
+    close(socketFd);
+
+    resultsMutex.lock();
+    latencies.insert(latencies.end(), myLatencies.begin(), myLatencies.end());
+    answered += myAnswered;
+    expired += myExpired;
+    busy += myBusy;
+    malformed += myMalformed;
+    failed += myFailed;
+    resultsMutex.unlock();
+}
+
+/**
+* Runs all the connections concurrently and prints the throughput and
+* the latency percentiles of the answered queries.
+*/
+void LoadClient::run()
+{
+    cout << "Sending " << totalRequests << " queries over " << noConnections << " connections to " << socketPath << endl;
+
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    vector<thread> threads(noConnections);
+    for(unsigned int i = 0; i < threads.size(); ++i)
+    {
+        threads[i] = thread(&LoadClient::connectionLoop, this);
+    }
+    for(unsigned int i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    cout << "Answered: " << answered << ", expired: " << expired << ", busy: " << busy
+         << ", malformed: " << malformed << ", failed: " << failed << endl;
+    cout << "Elapsed: " << seconds << " seconds, QPS: " << answered / seconds << endl;
+
+    if(latencies.empty())
+    {
+        return;
+    }
+
+    sort(latencies.begin(), latencies.end());
+    double percentiles[] = {50, 90, 99, 99.9};
+    cout << "Latency (microseconds):";
+    for(int i = 0; i < 4; i++)
+    {
+        size_t position = (size_t) (percentiles[i] / 100.0 * (latencies.size() - 1));
+        cout << "  p" << percentiles[i] << "=" << latencies[position];
+    }
+    cout << "  max=" << latencies.back() << endl;
+}
@@ -0,0 +1,845 @@
+#include <iostream>
+#include <stdlib.h> //atoi
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h> //strerror
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include "QueryServer.h"
+
+using namespace std;
+
+//epoll identifiers of the descriptors that are not connections
+static const long LISTEN_ID = 0;
+static const long WAKE_ID = 1;
+static const long SIGNAL_ID = 2;
+static const long STDOUT_ID = 3;
+static const long FIRST_CONNECTION_ID = 4;
+
+//a client that sends a longer line than this without a newline is disconnected
+static const size_t MAX_LINE_LENGTH = 64 * 1024;
+
+//while more answers than this wait for a client, we stop reading its lines
+static const size_t MAX_OUTPUT_LENGTH = 4 * MAX_LINE_LENGTH;
+
+//the index is compacted when this part of the documents is deleted but not purged
+static const float COMPACTION_RATIO = 0.1;
+
+/**
+* Keeps the settings of the server. Nothing is created
+* until start() is called.
+*/
+QueryServer::QueryServer(InvertedIndex *index, string socketPath, int noWorkers, unsigned int maxQueued, int deadlineMillis)
+{
+    this->index = index;
+    this->socketPath = socketPath;
+    this->noWorkers = noWorkers > 0 ? noWorkers : 1;
+    this->maxQueued = maxQueued > 0 ? maxQueued : 1;
+    this->deadlineMillis = deadlineMillis;
+
+    epollFd = listenFd = wakeFd = signalFd = -1;
+    nextConnectionID = FIRST_CONNECTION_ID;
+    stdoutConnectionID = -1;
+    stdoutFlags = 0;
+    stopping = false;
+    acceptedQueries = rejectedQueries = malformedQueries = 0;
+    answeredQueries = 0;
+    expiredQueries = 0;
+    commandsExecuted = 0;
+    compactionRequested = false;
+    compactions = 0;
+}
+
+/**
+* Stops the workers if they are still running, closes every
+* descriptor and removes the socket file.
+*/
+QueryServer::~QueryServer()
+{
+    requestsMutex.lock();
+    stopping = true;
+    requestsMutex.unlock();
+    requestsCondition.notify_all();
+    maintenanceCondition.notify_all();
+
+    for(unsigned int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    if(maintainer.joinable())
+    {
+        maintainer.join();
+    }
+
+    while(!connections.empty())
+    {
+        closeConnection(connections.begin()->first);
+    }
+
+    if(listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+    if(wakeFd >= 0) close(wakeFd);
+    if(signalFd >= 0) close(signalFd);
+    if(epollFd >= 0) close(epollFd);
+}
+
+/**
+* Checks that a line has the format of the queries file: "<queryID> <top-k> <words>".
+* The index expects both numbers followed by a space, and top-k must be at least one.
+*/
+bool QueryServer::isValidQuery(const string &queryLine)
+{
+    unsigned int i = 0;
+
+    for(int field = 0; field < 2; field++)
+    {
+        unsigned int start = i;
+        while(i < queryLine.length() && queryLine[i] >= '0' && queryLine[i] <= '9')
+        {
+            i++;
+        }
+
+        //empty numbers or numbers that do not fit in an int
+        if(i == start || i - start > 9)
+        {
+            return false;
+        }
+        if(field == 1 && atoi(queryLine.c_str() + start) == 0)
+        {
+            return false;
+        }
+        if(i >= queryLine.length() || queryLine[i] != ' ')
+        {
+            return false;
+        }
+        i++;
+    }
+
+    return true;
+}
+
+/**
+* Checks that a line is one of the commands that change the index:
+* "delete <docID>", "update <docID> <text>" or "compact".
+*/
+bool QueryServer::isValidCommand(const string &commandLine)
+{
+    if(commandLine == "compact")
+    {
+        return true;
+    }
+
+    unsigned int i;
+    if(commandLine.compare(0, 7, "delete ") == 0 || commandLine.compare(0, 7, "update ") == 0)
+    {
+        i = 7;
+    }
+    else
+    {
+        return false;
+    }
+
+    unsigned int start = i;
+    while(i < commandLine.length() && commandLine[i] >= '0' && commandLine[i] <= '9')
+    {
+        i++;
+    }
+    if(i == start || i - start > 9)
+    {
+        return false;
+    }
+
+    //delete takes only the docID, update also needs the new text after a space
+    if(commandLine[0] == 'd')
+    {
+        return i == commandLine.length();
+    }
+    return i < commandLine.length() && commandLine[i] == ' ';
+}
+
+/**
+* Creates the unix domain socket, the epoll instance and the worker threads.
+* SIGINT and SIGTERM are blocked here, before any worker exists, so they
+* are only received through the signalfd of the event loop.
+*/
+bool QueryServer::start()
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN); //a client that left must not kill the server
+
+    struct sockaddr_un address;
+    if(socketPath.length() >= sizeof(address.sun_path))
+    {
+        cerr << "Socket path is too long: " << socketPath << endl;
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(epollFd < 0 || wakeFd < 0 || signalFd < 0 || listenFd < 0)
+    {
+        cerr << "Could not create the server descriptors: " << strerror(errno) << endl;
+        return false;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath.c_str());
+    unlink(socketPath.c_str()); //a socket left from a previous run
+
+    if(bind(listenFd, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(listenFd, SOMAXCONN) < 0)
+    {
+        cerr << "Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    event.data.u64 = SIGNAL_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+
+    cout << "Serving queries on " << socketPath << " with " << noWorkers << " workers"
+         << " (queue limit " << maxQueued << ", deadline " << deadlineMillis << " ms)" << endl;
+
+    //queries can also be typed on the standard input, the answers go to the standard output
+    addConnection(STDIN_FILENO, STDOUT_FILENO);
+
+    for(int i = 0; i < noWorkers; i++)
+    {
+        workers.push_back(thread(&QueryServer::workerLoop, this));
+    }
+    maintainer = thread(&QueryServer::maintenanceLoop, this);
+
+    return true;
+}
+
+/**
+* The event loop. Waits for new clients, incoming queries, finished
+* answers and the termination signal, until the signal arrives.
+*/
+void QueryServer::run()
+{
+    struct epoll_event events[64];
+    bool finished = false;
+
+    while(!finished)
+    {
+        int ready = epoll_wait(epollFd, events, 64, -1);
+        if(ready < 0)
+        {
+            if(errno == EINTR) continue;
+            cerr << "epoll_wait failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        for(int i = 0; i < ready; i++)
+        {
+            long id = events[i].data.u64;
+
+            if(id == LISTEN_ID)
+            {
+                acceptConnections();
+            }
+            else if(id == WAKE_ID)
+            {
+                uint64_t value;
+                while(read(wakeFd, &value, sizeof(value)) > 0);
+                deliverResponses();
+            }
+            else if(id == STDOUT_ID)
+            {
+                if(connections.find(stdoutConnectionID) != connections.end())
+                {
+                    flushConnection(stdoutConnectionID);
+                }
+            }
+            else if(id == SIGNAL_ID)
+            {
+                struct signalfd_siginfo info;
+                while(read(signalFd, &info, sizeof(info)) > 0);
+                finished = true;
+            }
+            else
+            {
+                //the connection may have been closed by a previous event of this round
+                if(connections.find(id) == connections.end()) continue;
+
+                if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    readConnection(id);
+                }
+                if(connections.find(id) != connections.end() && (events[i].events & EPOLLOUT))
+                {
+                    flushConnection(id);
+                }
+            }
+        }
+    }
+
+    //queries and updates that are still in the queues are dropped
+    requestsMutex.lock();
+    stopping = true;
+    requests.clear();
+    maintenanceRequests.clear();
+    requestsMutex.unlock();
+    requestsCondition.notify_all();
+    maintenanceCondition.notify_all();
+
+    for(unsigned int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+    maintainer.join();
+
+    //gives the standard output back its blocking mode before we print to it
+    if(connections.find(stdoutConnectionID) != connections.end())
+    {
+        closeConnection(stdoutConnectionID);
+    }
+
+    cout << endl << "Server stopped. Queries accepted: " << acceptedQueries
+         << ", answered: " << answeredQueries
+         << ", expired: " << expiredQueries
+         << ", commands executed: " << commandsExecuted
+         << ", rejected as busy: " << rejectedQueries
+         << ", malformed: " << malformedQueries
+         << ", compactions: " << compactions << endl;
+}
+
+/**
+* Executed by the worker threads. Takes the oldest query, answers it
+* (or answers "Expired:" without executing it, if it waited more than its deadline) and wakes up the event loop.
+*/
+void QueryServer::workerLoop()
+{
+    while(true)
+    {
+        unique_lock<mutex> lock(requestsMutex);
+        requestsCondition.wait(lock, [this]{ return stopping || !requests.empty(); });
+        if(stopping)
+        {
+            return;
+        }
+        QueryRequest request = requests.front();
+        requests.pop_front();
+        lock.unlock();
+
+        string answer;
+
+        if(chrono::steady_clock::now() > request.deadline)
+        {
+            answer = "Expired: query \"" + request.queryLine + "\" waited more than its deadline\n\n";
+            expiredQueries++;
+        }
+        else if(request.queryLine[0] >= '0' && request.queryLine[0] <= '9')
+        {
+            answer = index->answerQuery(request.queryLine);
+            answeredQueries++;
+        }
+        else
+        {
+            answer = executeCommand(request.queryLine);
+        }
+
+        pushResponse(request.connectionID, answer);
+    }
+}
+
+/**
+* Queues an answer for the event loop and wakes it up.
+*/
+void QueryServer::pushResponse(long connectionID, const string &text)
+{
+    QueryResponse response;
+    response.connectionID = connectionID;
+    response.text = text;
+
+    responsesMutex.lock();
+    responses.push_back(response);
+    responsesMutex.unlock();
+
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void) written; //if the counter is full, the event loop is already awake
+}
+
+/**
+* Executes a command that changes the index. Deletions are executed by the workers,
+* updates and compactions by the maintainer. Deletions and updates only mark the
+* documents; when enough of them are marked, a compaction removes them from the lists.
+*/
+string QueryServer::executeCommand(const string &commandLine)
+{
+    commandsExecuted++;
+
+    if(commandLine == "compact")
+    {
+        //commands that arrived meanwhile asked for a compaction that this one covers
+        requestsMutex.lock();
+        compactionRequested = false;
+        requestsMutex.unlock();
+
+        long postings = index->compact();
+        compactions++;
+        return "Compacted: " + to_string(postings) + " postings\n\n";
+    }
+
+    int docID = atoi(commandLine.c_str() + 7);
+    string reply;
+
+    if(commandLine[0] == 'd')
+    {
+        if(!index->deleteDocument(docID))
+        {
+            return "Not found: document " + to_string(docID) + "\n\n";
+        }
+        reply = "Deleted: document " + to_string(docID) + "\n\n";
+    }
+    else
+    {
+        int newDocID = index->updateDocument(docID, commandLine.substr(commandLine.find(' ', 7) + 1));
+        if(newDocID < 0)
+        {
+            return "Not found: document " + to_string(docID) + "\n\n";
+        }
+        reply = "Updated: document " + to_string(docID) + " is now document " + to_string(newDocID) + "\n\n";
+    }
+
+    if(index->deletedRatio() >= COMPACTION_RATIO)
+    {
+        requestCompaction();
+    }
+
+    return reply;
+}
+
+/**
+* Asks the maintainer to compact. Requests that arrive while it is
+* already compacting result in one more compaction.
+*/
+void QueryServer::requestCompaction()
+{
+    requestsMutex.lock();
+    compactionRequested = true;
+    requestsMutex.unlock();
+    maintenanceCondition.notify_one();
+}
+
+/**
+* Executed by the maintainer thread. Updates and compactions exclude each other,
+* so they run here one at a time and never hold a query worker. An update that
+* arrives during a compaction waits in the queue; its answer is sent when it is done.
+* The queries only wait for the short moments the index is locked for writing.
+*/
+void QueryServer::maintenanceLoop()
+{
+    while(true)
+    {
+        unique_lock<mutex> lock(requestsMutex);
+        maintenanceCondition.wait(lock, [this]{ return stopping || compactionRequested || !maintenanceRequests.empty(); });
+        if(stopping)
+        {
+            return;
+        }
+
+        if(!maintenanceRequests.empty())
+        {
+            QueryRequest request = maintenanceRequests.front();
+            maintenanceRequests.pop_front();
+            lock.unlock();
+
+            pushResponse(request.connectionID, executeCommand(request.queryLine));
+        }
+        else
+        {
+            compactionRequested = false;
+            lock.unlock();
+
+            //the deletions that asked for it during the previous compaction may be purged already
+            if(index->deletedRatio() >= COMPACTION_RATIO)
+            {
+                index->compact();
+                compactions++;
+            }
+        }
+    }
+}
+
+/**
+* Accepts all the clients that are waiting on the listening socket.
+*/
+void QueryServer::acceptConnections()
+{
+    while(true)
+    {
+        int clientFd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(clientFd < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                cerr << "accept failed: " << strerror(errno) << endl;
+            }
+            return;
+        }
+        addConnection(clientFd, clientFd);
+    }
+}
+
+/**
+* Registers a new client at the event loop. For the standard input
+* this can fail (e.g. when it is a regular file), then it is not served.
+*/
+void QueryServer::addConnection(int inFd, int outFd)
+{
+    long id = nextConnectionID++;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    if(epoll_ctl(epollFd, EPOLL_CTL_ADD, inFd, &event) < 0)
+    {
+        if(inFd != STDIN_FILENO)
+        {
+            close(inFd);
+        }
+        return;
+    }
+
+    Connection connection;
+    connection.inFd = inFd;
+    connection.outFd = outFd;
+    connection.pending = 0;
+    connection.commandPending = false;
+    connection.closing = false;
+    connection.events = EPOLLIN;
+    connection.outEvents = 0;
+    connections[id] = connection;
+
+    //a full pipe on the standard output must not stop the event loop
+    if(outFd == STDOUT_FILENO)
+    {
+        stdoutFlags = fcntl(STDOUT_FILENO, F_GETFL);
+        fcntl(STDOUT_FILENO, F_SETFL, stdoutFlags | O_NONBLOCK);
+        stdoutConnectionID = id;
+    }
+}
+
+/**
+* Reads once from the client and handles the full lines received.
+* Epoll is level triggered, so anything left is reported again.
+*/
+void QueryServer::readConnection(long connectionID)
+{
+    Connection &connection = connections[connectionID];
+    char buffer[4096];
+
+    ssize_t received = read(connection.inFd, buffer, sizeof(buffer));
+    if(received < 0)
+    {
+        if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            closeConnection(connectionID);
+        }
+        return;
+    }
+
+    if(received == 0) //the client finished sending, a last line may have no newline
+    {
+        if(!connection.inBuffer.empty() && connection.inBuffer[connection.inBuffer.length() - 1] != '\n')
+        {
+            connection.inBuffer += '\n';
+        }
+        connection.closing = true;
+        flushConnection(connectionID);
+        return;
+    }
+
+    connection.inBuffer.append(buffer, received);
+
+    size_t lastNewline = connection.inBuffer.rfind('\n');
+    size_t partialLength = connection.inBuffer.length() - (lastNewline == string::npos ? 0 : lastNewline + 1);
+    if(partialLength > MAX_LINE_LENGTH)
+    {
+        closeConnection(connectionID);
+        return;
+    }
+
+    flushConnection(connectionID);
+}
+
+/**
+* Handles the full lines of the client while its unwritten answers are less than
+* MAX_OUTPUT_LENGTH. The rest are kept until the client reads its answers.
+* Commands are executed in the order they were sent: a command waits until the earlier
+* lines of its connection are answered, and the later lines wait for the command.
+* Returns true if any line was handled.
+*/
+bool QueryServer::handleBufferedLines(long connectionID)
+{
+    Connection &connection = connections[connectionID];
+
+    size_t start = 0, newline;
+    while(connection.outBuffer.length() < MAX_OUTPUT_LENGTH && !connection.commandPending
+          && (newline = connection.inBuffer.find('\n', start)) != string::npos)
+    {
+        string line = connection.inBuffer.substr(start, newline - start);
+        if(!line.empty() && line[line.length() - 1] == '\r')
+        {
+            line.erase(line.length() - 1);
+        }
+
+        if(isValidCommand(line))
+        {
+            if(connection.pending > 0)
+            {
+                break;
+            }
+            connection.commandPending = handleLine(connectionID, line);
+        }
+        else
+        {
+            handleLine(connectionID, line);
+        }
+        start = newline + 1;
+    }
+    connection.inBuffer.erase(0, start);
+
+    return start > 0;
+}
+
+/**
+* Admission control for a single query. Malformed queries and queries that find
+* the queue full are answered at once; the rest wait for a worker until their deadline.
+* Updates and compact commands go to the queue of the maintainer and have no deadline,
+* since they may have to wait for a whole compaction.
+* Returns true if the line was queued.
+*/
+bool QueryServer::handleLine(long connectionID, const string &line)
+{
+    Connection &connection = connections[connectionID];
+
+    if(line.empty())
+    {
+        return false;
+    }
+
+    if(!isValidQuery(line) && !isValidCommand(line))
+    {
+        malformedQueries++;
+        connection.outBuffer += "Malformed: query \"" + line + "\" is not \"<queryID> <top-k> <words>\", \"delete <docID>\", \"update <docID> <text>\" or \"compact\"\n\n";
+        return false;
+    }
+
+    bool maintenance = line == "compact" || line.compare(0, 7, "update ") == 0;
+    deque<QueryRequest> &queue = maintenance ? maintenanceRequests : requests;
+
+    requestsMutex.lock();
+    if(queue.size() >= maxQueued)
+    {
+        requestsMutex.unlock();
+        rejectedQueries++;
+        connection.outBuffer += "Busy: query \"" + line + "\" was rejected, try again later\n\n";
+        return false;
+    }
+
+    QueryRequest request;
+    request.connectionID = connectionID;
+    request.queryLine = line;
+    request.deadline = chrono::steady_clock::now() + chrono::milliseconds(deadlineMillis);
+    queue.push_back(request);
+    requestsMutex.unlock();
+    if(maintenance)
+    {
+        maintenanceCondition.notify_one();
+    }
+    else
+    {
+        requestsCondition.notify_one();
+    }
+
+    acceptedQueries++;
+    connection.pending++;
+
+    return true;
+}
+
+/**
+* Gives the answers of the workers to their connections. Answers for
+* clients that have already left are thrown away.
+*/
+void QueryServer::deliverResponses()
+{
+    deque<QueryResponse> finished;
+
+    responsesMutex.lock();
+    finished.swap(responses);
+    responsesMutex.unlock();
+
+    for(unsigned int i = 0; i < finished.size(); i++)
+    {
+        unordered_map<long, Connection>::iterator it = connections.find(finished[i].connectionID);
+        if(it == connections.end())
+        {
+            continue;
+        }
+        it->second.pending--;
+        if(it->second.pending == 0)
+        {
+            it->second.commandPending = false; //it was the only request we let run
+        }
+        it->second.outBuffer += finished[i].text;
+        flushConnection(finished[i].connectionID);
+    }
+}
+
+/**
+* Writes the pending answers of a client until it would block, handling the lines
+* that were kept back as soon as there is room for their answers. A client that
+* has finished sending is closed when it has received all its answers.
+*/
+void QueryServer::flushConnection(long connectionID)
+{
+    Connection &connection = connections[connectionID];
+
+    do
+    {
+        while(!connection.outBuffer.empty())
+        {
+            ssize_t written;
+            if(connection.outFd == STDOUT_FILENO)
+            {
+                written = write(connection.outFd, connection.outBuffer.data(), connection.outBuffer.length());
+            }
+            else
+            {
+                written = send(connection.outFd, connection.outBuffer.data(), connection.outBuffer.length(), MSG_NOSIGNAL);
+            }
+
+            if(written < 0)
+            {
+                if(errno == EINTR) continue;
+                if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+                closeConnection(connectionID);
+                return;
+            }
+            connection.outBuffer.erase(0, written);
+        }
+    } while(handleBufferedLines(connectionID));
+
+    if(connection.closing && connection.pending == 0 && connection.outBuffer.empty() && connection.inBuffer.empty())
+    {
+        closeConnection(connectionID);
+        return;
+    }
+
+    updateEvents(connectionID);
+}
+
+/**
+* A socket waits for input until the client finishes sending, or while too many answers
+* or held back lines wait, and for output while answers are pending. The standard input
+* is just removed from epoll when it is not read, and the standard output is
+* registered separately while answers are pending.
+*/
+void QueryServer::updateEvents(long connectionID)
+{
+    Connection &connection = connections[connectionID];
+
+    unsigned int wanted = 0;
+    if(!connection.closing && connection.outBuffer.length() < MAX_OUTPUT_LENGTH && connection.inBuffer.length() < MAX_OUTPUT_LENGTH)
+    {
+        wanted |= EPOLLIN;
+    }
+    if(connection.inFd == connection.outFd && !connection.outBuffer.empty())
+    {
+        wanted |= EPOLLOUT;
+    }
+
+    if(wanted != connection.events)
+    {
+        if(wanted == 0)
+        {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.inFd, NULL);
+        }
+        else
+        {
+            struct epoll_event event;
+            event.events = wanted;
+            event.data.u64 = connectionID;
+            epoll_ctl(epollFd, connection.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, connection.inFd, &event);
+        }
+        connection.events = wanted;
+    }
+
+    unsigned int wantedOut = 0;
+    if(connection.inFd != connection.outFd && !connection.outBuffer.empty())
+    {
+        wantedOut = EPOLLOUT;
+    }
+
+    if(wantedOut != connection.outEvents)
+    {
+        if(wantedOut == 0)
+        {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.outFd, NULL);
+        }
+        else
+        {
+            struct epoll_event event;
+            event.events = wantedOut;
+            event.data.u64 = STDOUT_ID;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.outFd, &event);
+        }
+        connection.outEvents = wantedOut;
+    }
+}
+
+/**
+* Removes a client from the event loop and closes its socket.
+* The standard input and output are never closed.
+*/
+void QueryServer::closeConnection(long connectionID)
+{
+    Connection &connection = connections[connectionID];
+
+    if(connection.events != 0)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.inFd, NULL);
+    }
+    if(connection.outEvents != 0)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.outFd, NULL);
+    }
+    if(connection.outFd == STDOUT_FILENO)
+    {
+        fcntl(STDOUT_FILENO, F_SETFL, stdoutFlags);
+        stdoutConnectionID = -1;
+    }
+    if(connection.inFd != STDIN_FILENO)
+    {
+        close(connection.inFd);
+    }
+    connections.erase(connectionID);
+}